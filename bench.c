@@ -0,0 +1,81 @@
+#include "bench.h"
+#include <stdio.h>
+#include "NU32.h"
+#include "isense.h"
+#include "encoder.h"
+#include "currentcontrol.h"
+#include "positioncontrol.h"
+#include "gainsched.h"
+#include "benchkernels.h"
+
+#define BENCH_KERNELS 15           // number of result lines sent to the client
+
+// Inputs are read from volatile vars and results written to one, so the
+// compiler can neither fold the kernels into constants nor drop them.
+static volatile int in_a = 37, in_b = -1200, in_c = 3;
+static volatile unsigned int in_counts = 612;
+static volatile int sink;
+
+// Send one result line: kernel name and core clock cycles per call, with the
+// cost of the empty timing loop taken out. The core timer ticks once every
+// two SYSCLK cycles.
+static void bench_report(const char *label, unsigned int ticks, unsigned int loop_ticks, int iters){
+  char buffer[64];
+  float cycles = 2.0 * ((float)ticks - (float)loop_ticks) / iters;
+  sprintf(buffer, "%s %.1f\r\n", label, cycles);
+  NU32_WriteUART3(buffer);
+}
+
+void bench_run(int iters){
+  char buffer[64];
+  const char *name[BENCH_KERNELS];
+  unsigned int start, loop, t[BENCH_KERNELS];
+  float kpI = 0.75, kiI = 0.05, kpP = 150.0, kiP = 0.0, kdP = 5000;
+  int kpI_q = 0.75*65536, kiI_q = 0.05*65536, kpP_q = 150*65536, kiP_q = 0, kdP_q = 5000*65536;
+  int i, n, k = 0;
+
+  if (iters < 1){iters = 1;}
+  if (iters > BENCH_MAX_ITERS){iters = BENCH_MAX_ITERS;}
+
+  // Time everything first, with interrupts off, so no ISR or UART traffic
+  // lands inside a measurement:
+  __builtin_disable_interrupts();
+
+  start = _CP0_GET_COUNT();
+  for (i = 0; i < iters; i++){sink = in_a;}
+  loop = _CP0_GET_COUNT() - start;
+
+#define BENCH_TIME(label, expr) \
+  start = _CP0_GET_COUNT(); \
+  for (i = 0; i < iters; i++){sink = (expr);} \
+  t[k] = _CP0_GET_COUNT() - start; \
+  name[k++] = label
+
+  BENCH_TIME("current_pi_float", current_pi(in_a, in_b, kpI, kiI));
+  BENCH_TIME("current_pi_q16", current_pi_q16(in_a, in_b, kpI_q, kiI_q));
+  BENCH_TIME("position_pid_float", position_pid(in_a, in_b, in_c, kpP, kiP, kdP));
+  BENCH_TIME("position_pid_q16", position_pid_q16(in_a, in_b, in_c, kpP_q, kiP_q, kdP_q));
+  BENCH_TIME("dob_update", dob_update(in_a, in_counts));
+  BENCH_TIME("gs_lookup", gs_lookup(GS_POSITION, in_b).kp);
+  BENCH_TIME("counts_to_ma_float", isense_counts_to_ma(in_counts));
+  BENCH_TIME("counts_to_ma_q8", isense_counts_to_ma_q8(in_counts));
+  BENCH_TIME("read_cur_amps", read_cur_amps());
+  BENCH_TIME("counts_to_degs_int", encoder_counts_to_degs(in_counts));
+  BENCH_TIME("counts_to_degs_q16", encoder_counts_to_degs_q16(in_counts));
+  BENCH_TIME("encoder_degs", encoder_degs());
+  BENCH_TIME("sprintf_int", sprintf(buffer, "%d %d\r\n", in_a, in_b));
+  BENCH_TIME("sprintf_float", sprintf(buffer, "%f\r\n", kpP));
+  BENCH_TIME("sscanf_int", sscanf("-1234", "%d", &n));
+
+#undef BENCH_TIME
+
+  dob_reset();              // observer was fed fake samples above
+  __builtin_enable_interrupts();
+
+  // Then send the table:
+  sprintf(buffer, "%d %d\r\n", BENCH_KERNELS, iters);
+  NU32_WriteUART3(buffer);
+  for (k = 0; k < BENCH_KERNELS; k++){
+    bench_report(name[k], t[k], loop, iters);
+  }
+}
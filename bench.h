@@ -0,0 +1,10 @@
+#ifndef BENCH__H__
+#define BENCH__H__
+
+#include <xc.h>                     // processor SFR definitions
+
+#define BENCH_MAX_ITERS 100000      // cap on iterations per kernel
+
+void bench_run(int iters);          // time each control kernel, report cycles/call over UART
+
+#endif // BENCH__H__
@@ -0,0 +1,80 @@
+// Host benchmark of the control kernels, float and fixed-point versions.
+//
+//   make bench-host            (writes bench_host.csv)
+//
+// Each kernel is run in batches until at least BENCH_MIN_NS has passed, then
+// the cost per call (ns) is printed and saved as "kernel,ns_per_call,iterations".
+// Host numbers only rank the variants and catch regressions; for ISR cost on
+// the PIC32 use the 'u' menu command.
+#include <stdio.h>
+#include <time.h>
+#include "isense.h"
+#include "encoder.h"
+#include "currentcontrol.h"
+#include "positioncontrol.h"
+#include "gainsched.h"
+#include "benchkernels.h"
+
+#define BENCH_MIN_NS 200000000LL      // run each kernel for at least 0.2 s
+
+static volatile int in_a = 37, in_b = -1200, in_c = 3;
+static volatile unsigned int in_counts = 612;
+static volatile float in_f = 150.0;
+static volatile int sink;
+static char buffer[64];
+static FILE *out;
+
+static long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void report(const char *name, long long ns, long long iters){
+  double per_call = (double)ns / iters;
+  printf("%-22s %10.2f ns %12lld iterations\n", name, per_call, iters);
+  fprintf(out, "%s,%.3f,%lld\n", name, per_call, iters);
+}
+
+// Double the batch size until a batch takes BENCH_MIN_NS, then report it:
+#define BENCH(label, expr) do { \
+    long long b_n, b_i, b_t0, b_dt = 0; \
+    for (b_n = 1000; b_dt < BENCH_MIN_NS; b_n *= 2){ \
+      b_t0 = now_ns(); \
+      for (b_i = 0; b_i < b_n; b_i++){sink = (expr);} \
+      b_dt = now_ns() - b_t0; \
+    } \
+    report(label, b_dt, b_n / 2); \
+  } while (0)
+
+int main(int argc, char *argv[]){
+  const char *file = (argc > 1) ? argv[1] : "bench_host.csv";
+  int n;
+
+  out = fopen(file, "w");
+  if (out == NULL){
+    perror(file);
+    return 1;
+  }
+  fprintf(out, "kernel,ns_per_call,iterations\n");
+  gs_init();
+  dob_set_bandwidth(10);
+
+  BENCH("current_pi_float", current_pi(in_a, in_b, 0.75, 0.05));
+  BENCH("current_pi_q16", current_pi_q16(in_a, in_b, 49152, 3277));
+  BENCH("position_pid_float", position_pid(in_a, in_b, in_c, 150.0, 0.0, 5000));
+  BENCH("position_pid_q16", position_pid_q16(in_a, in_b, in_c, 150*65536, 0, 5000*65536));
+  BENCH("dob_update", dob_update(in_a, in_counts));
+  BENCH("gs_lookup", gs_lookup(GS_POSITION, in_b).kp);
+  BENCH("counts_to_ma_float", isense_counts_to_ma(in_counts));
+  BENCH("counts_to_ma_q8", isense_counts_to_ma_q8(in_counts));
+  BENCH("counts_to_degs_int", encoder_counts_to_degs(in_counts));
+  BENCH("counts_to_degs_q16", encoder_counts_to_degs_q16(in_counts));
+  BENCH("sprintf_int", sprintf(buffer, "%d %d\r\n", in_a, in_b));
+  BENCH("sprintf_float", sprintf(buffer, "%f\r\n", in_f));
+  BENCH("sscanf_int", sscanf("-1234", "%d", &n));
+
+  fclose(out);
+  printf("results written to %s\n", file);
+  return 0;
+}
@@ -0,0 +1,9 @@
+#include <xc.h>
+
+// Storage for the SFR stand-ins declared in bench/xc.h
+volatile sfr_bits_t T2CONbits, T3CONbits, T4CONbits, OC1CONbits, TRISDbits, LATDbits;
+volatile sfr_bits_t IPC2bits, IPC4bits, IFS0bits, IEC0bits, SPI4STATbits, SPI4CONbits;
+volatile sfr_bits_t AD1PCFGbits, AD1CON1bits, AD1CON3bits, AD1CHSbits;
+volatile unsigned int PR2 = 1999, PR3 = 3999, PR4 = 6249, TMR2, TMR3, TMR4, OC1RS, OC1R;
+volatile unsigned int SPI4BUF, SPI4BRG, SPI4CON, ADC1BUF0;
+volatile unsigned int IEC0CLR, IEC0SET, IFS0CLR;
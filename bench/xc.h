@@ -0,0 +1,28 @@
+#ifndef BENCH_XC__H__
+#define BENCH_XC__H__
+
+// Host stand-in for <xc.h>, only for the bench-host target. The SFRs the
+// control modules touch become plain variables (defined in sfr_host.c), so
+// their pure kernels can be compiled and timed on Linux. Nothing here models
+// the hardware: the init, SPI and ADC functions must not be called.
+
+typedef struct {
+  unsigned ON, TCKPS, OCTSEL, OCM, TRISD8, LATD8, T2IP, T4IP, T2IF, T4IF, T2IE, T4IE;
+  unsigned SPIRBF, SPIROV, MSTEN, MSSEN, MODE16, MODE32, SMP;
+  unsigned PCFG0, ADCS, ADON, CH0SA, SSRC, SAMP, DONE;
+} sfr_bits_t;
+
+extern volatile sfr_bits_t T2CONbits, T3CONbits, T4CONbits, OC1CONbits, TRISDbits, LATDbits;
+extern volatile sfr_bits_t IPC2bits, IPC4bits, IFS0bits, IEC0bits, SPI4STATbits, SPI4CONbits;
+extern volatile sfr_bits_t AD1PCFGbits, AD1CON1bits, AD1CON3bits, AD1CHSbits;
+extern volatile unsigned int PR2, PR3, PR4, TMR2, TMR3, TMR4, OC1RS, OC1R;
+extern volatile unsigned int SPI4BUF, SPI4BRG, SPI4CON, ADC1BUF0;
+extern volatile unsigned int IEC0CLR, IEC0SET, IFS0CLR;
+
+#define _IEC0_T2IE_MASK 0x00000200
+#define _IFS0_T2IF_MASK 0x00000200
+#define _IEC0_T4IE_MASK 0x00010000
+#define _IFS0_T4IF_MASK 0x00010000
+#define _CP0_GET_COUNT() 0u
+
+#endif // BENCH_XC__H__
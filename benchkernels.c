@@ -0,0 +1,17 @@
+#include "benchkernels.h"
+
+int current_pi_q16(int e, int eint, int kp, int ki){
+  return ((long long)kp*e + (long long)ki*eint) >> 16;
+}
+
+int position_pid_q16(int e, int eint, int edot, int kp, int ki, int kd){
+  return ((long long)kp*e + (long long)ki*eint + (long long)kd*edot) >> 16;
+}
+
+int isense_counts_to_ma_q8(unsigned int cur_counts){
+  return ((int)(cur_counts * 522) >> 8) - 1024;     // 2.04 in Q8
+}
+
+int encoder_counts_to_degs_q16(int counts){
+  return ((counts - 32768) * 13165) >> 16;          // 360/1792 in Q16
+}
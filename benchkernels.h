@@ -0,0 +1,12 @@
+#ifndef BENCHKERNELS__H__
+#define BENCHKERNELS__H__
+
+// Fixed-point candidates for the float control kernels. Plain C, so the
+// on-target 'u' command and the host benchmark time the same code.
+
+int current_pi_q16(int e, int eint, int kp, int ki);                  // gains in Q16
+int position_pid_q16(int e, int eint, int edot, int kp, int ki, int kd);  // gains in Q16
+int isense_counts_to_ma_q8(unsigned int cur_counts);                  // ADC counts to mA
+int encoder_counts_to_degs_q16(int counts);                           // encoder counts to deg
+
+#endif // BENCHKERNELS__H__
@@ -43,6 +43,9 @@ while ~has_quit
     fprintf('m: Load step trajectory                n: Load cubic trajectory\n');
     fprintf('o: Execute trajectory                  p: Unpower the motor\n');
     fprintf('q: Quit client                         r: Get mode\n');
+    fprintf('s: Set observer bandwidth (Hz)         t: Get observer bandwidth (Hz)\n');
+    fprintf('u: Benchmark control kernels           v: Measure frequency response\n');
+    fprintf('w: Set gain schedule                   x: Get gain schedule\n');
     % read the user's choice
     selection = input('\nENTER COMMAND: ', 's');
      
@@ -138,30 +141,34 @@ while ~has_quit
             des_traj = input('\nEnter step trajectory, in sec and degrees [time1, ang1; time2, ang2; ...]: ');
             step_traj = genRef(des_traj, 'step');
             num_samples = size(step_traj, 2);
-            if num_samples > 2000
-                fprintf('\nError: Maximum trajectory time is 10 seconds.\n'); 
-            end
-
-            fprintf(mySerial, '%d\n', num_samples);  
-            for i=1:num_samples
-                fprintf(mySerial, '%d\n',step_traj(i));
+            max_samples = fscanf(mySerial,'%d');   % MAXSAMPS on the PIC32
+            if num_samples > max_samples
+                fprintf('\nError: Maximum trajectory time is %.1f seconds.\n', max_samples/200);
+                fprintf(mySerial, '%d\n', 0);     % PIC32 rejects it and keeps the old trajectory
+            else
+                fprintf(mySerial, '%d\n', num_samples);  
+                for i=1:num_samples
+                    fprintf(mySerial, '%d\n',step_traj(i));
+                end
+                fprintf('Plotting the desired trajectory and sending to PIC32 ... completed.\n')
             end
-            fprintf('Plotting the desired trajectory and sending to PIC32 ... completed.\n')
 
         % LOAD CUBIC TRAJECTORY:
         case 'n'                         
             des_traj = input('\nEnter cubic trajectory, in sec and degrees [time1, ang1; time2, ang2; ...]: ');
             step_traj = genRef(des_traj, 'cubic');
             num_samples = size(step_traj, 2);
-            if num_samples > 2000
-                fprintf('\nError: Maximum trajectory time is 10 seconds.\n'); 
-            end
-
-            fprintf(mySerial, '%d\n', num_samples);  
-            for i=1:num_samples
-                fprintf(mySerial, '%d\n',step_traj(i));
+            max_samples = fscanf(mySerial,'%d');   % MAXSAMPS on the PIC32
+            if num_samples > max_samples
+                fprintf('\nError: Maximum trajectory time is %.1f seconds.\n', max_samples/200);
+                fprintf(mySerial, '%d\n', 0);     % PIC32 rejects it and keeps the old trajectory
+            else
+                fprintf(mySerial, '%d\n', num_samples);  
+                for i=1:num_samples
+                    fprintf(mySerial, '%d\n',step_traj(i));
+                end
+                fprintf('Plotting the desired trajectory and sending to PIC32 ... completed.\n')
             end
-            fprintf('Plotting the desired trajectory and sending to PIC32 ... completed.\n')
 
         % EXECUTE TRAJECTORY AND PLOT:
         case 'o'                         
@@ -189,8 +196,70 @@ while ~has_quit
                     fprintf('The PIC32 controller mode is currently HOLD\n');
                 case 4
                     fprintf('The PIC32 controller mode is currently TRACK\n');
+                case 5
+                    fprintf('The PIC32 controller mode is currently IFRESP\n');
+                case 6
+                    fprintf('The PIC32 controller mode is currently PFRESP\n');
             end
                               
+        % SET DISTURBANCE OBSERVER BANDWIDTH AND PLANT INVERSE:
+        case 's'
+            dob_bw = input('\nEnter the load observer bandwidth in Hz, 0 to disable [recommended: 10, max: 50]: ');
+            dob_inv = input('Enter the plant inverse in mA per count/tick^2 (see positioncontrol.h) [default: 40]: ');
+            fprintf(mySerial, '%d %d\n', [dob_bw, dob_inv]);
+            fprintf('\nSending observer bandwidth = %d Hz and plant inverse = %d to the position controller.\n', dob_bw, dob_inv);
+
+        % GET DISTURBANCE OBSERVER BANDWIDTH AND PLANT INVERSE:
+        case 't'
+            n = fscanf(mySerial,'%d');
+            fprintf('The load observer bandwidth is %d Hz \n', n);
+            m = fscanf(mySerial,'%d');
+            fprintf('The load observer plant inverse is %d mA per count/tick^2 \n', m);
+
+        % BENCHMARK CONTROL KERNELS:
+        case 'u'
+            iters = input('\nEnter the number of iterations per kernel [recommended: 10000]: ');
+            fprintf(mySerial, '%d\n', iters);
+            read_bench(mySerial, 'bench_results.csv', 'bench_baseline.csv');
+
+        % MEASURE FREQUENCY RESPONSE:
+        case 'v'
+            loop = input('\nWhich loop, 0 = current or 1 = position? ');
+            if loop
+                amp = input('Enter the test amplitude in degrees [recommended: 20]: ');
+                fmin = input('Enter the lowest test frequency in Hz [recommended: 0.5]: ');
+                fmax = input('Enter the highest test frequency in Hz [max: 50]: ');
+            else
+                amp = input('Enter the test amplitude in mA [recommended: 200]: ');
+                fmin = input('Enter the lowest test frequency in Hz [recommended: 10]: ');
+                fmax = input('Enter the highest test frequency in Hz [max: 1250]: ');
+            end
+            npts = input('Enter the number of test frequencies [max: 50]: ');
+            fprintf(mySerial, '%d %d %f %f %d\n', [loop, amp, fmin, fmax, npts]);
+            read_bode(mySerial);
+
+        % SET GAIN SCHEDULE:
+        case 'w'
+            loop = input('\nWhich loop, 0 = current or 1 = position? ');
+            shift = input('Breakpoint spacing exponent s; breakpoints every 2^s mA or deg of |error| [0 to 10]: ');
+            sched = input('Gain scales at |error| = 0, 2^s, 2*2^s, ... [kp1, ki1, kd1; kp2, ki2, kd2; ...] (max 8 rows): ');
+            fprintf(mySerial, '%d %d %d\n', [loop, size(sched,1), shift]);
+            for i=1:size(sched,1)
+                fprintf(mySerial, '%f %f %f\n', sched(i,:));
+            end
+            fprintf('\nSending a %d entry gain schedule; [1, 1, 1] restores the fixed gains.\n', size(sched,1));
+
+        % GET GAIN SCHEDULE:
+        case 'x'
+            loop = input('\nWhich loop, 0 = current or 1 = position? ');
+            fprintf(mySerial, '%d\n', loop);
+            hdr = fscanf(mySerial, '%d %d');
+            fprintf('Gain scales, breakpoints every %d units of |error|:\n', 2^hdr(2));
+            for i=1:hdr(1)
+                row = fscanf(mySerial, '%f %f %f');
+                fprintf('  |e| = %5d:  Kp x %.3f  Ki x %.3f  Kd x %.3f\n', (i-1)*2^hdr(2), row);
+            end
+
         otherwise
             fprintf('Invalid Selection %c\n', selection);
     end
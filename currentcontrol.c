@@ -1,4 +1,5 @@
 #include "currentcontrol.h"
+#include <stdlib.h>
 
 void currentcontrol_init(void){
   // Initialize Timer2 interrupt for 5 kHz current control loop //
@@ -7,7 +8,7 @@ void currentcontrol_init(void){
   TMR2 = 0;                // initial Timer2 count is 0
   IPC2bits.T2IP = 5;       // priority for Timer2 interrupt
   IFS0bits.T2IF = 0;       // clear Timer2 interrupt flag
-  IEC0bits.T2IE = 1;       // enable Timer2 interrupt
+  IEC0bits.T2IE = 0;       // Timer2 interrupt is armed by set_mode() when a mode needs it
   T2CONbits.ON = 1;        // turn on Timer2
 
   // Initialize Timer3 and OutputCompare1 for 20 kHz PWM //
@@ -24,4 +25,33 @@ void currentcontrol_init(void){
   // Initialize digital output pin to control motor direction //
   TRISDbits.TRISD8 = 0;    // pin D8 set as digital output
   LATDbits.LATD8 = 0;      // output = low => motor in forward
+}
+
+// Uses the CLR/SET registers so an ISR changing another IEC0 bit can't be lost
+void currentcontrol_enable(int on){
+  if (on && !IEC0bits.T2IE){          // leave a running loop alone
+    TMR2 = 0;                         // full period before the first tick
+    IFS0CLR = _IFS0_T2IF_MASK;        // no stale tick
+    IEC0SET = _IEC0_T2IE_MASK;
+  }
+  else if (!on){
+    IEC0CLR = _IEC0_T2IE_MASK;
+    IFS0CLR = _IFS0_T2IF_MASK;
+  }
+}
+
+void currentcontrol_set_pwm(int duty){
+  if (duty < 0){
+    LATDbits.LATD8 = 1;    // output = high => motor in reverse
+  }
+  else{
+    LATDbits.LATD8 = 0;    // output = low => motor in forward
+  }
+  duty = abs(duty);
+  if (duty > 100){duty = 100;}    // cap to 100%
+  OC1RS = (unsigned int)((duty/100.0)*PR3);
+}
+
+int current_pi(int e, int eint, float kp, float ki){
+  return kp*e + ki*eint;
 }
\ No newline at end of file
@@ -3,6 +3,11 @@
 
 #include <xc.h>                     // processor SFR definitions
 
+#define CURRENT_LOOP_FREQ 5000      // current control loop rate (Hz)
+
 void currentcontrol_init(void);     // initialize peripherals for current control
+void currentcontrol_enable(int on); // arm (1) or gate off (0) the Timer2 interrupt
+void currentcontrol_set_pwm(int duty);  // apply duty cycle [-100 to 100] directly
+int current_pi(int e, int eint, float kp, float ki);   // PI control signal from error and its sum
 
 #endif // CURRENTCONTROL__H__
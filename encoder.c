@@ -16,11 +16,11 @@ int encoder_counts(void) {
 }
 
 int encoder_degs(void) {
-  encoder_command(1);
-  int counts, degs;
-  counts = encoder_command(1);
-  degs = (counts - 32768) * 360 / 1792;
-  return degs;
+  return encoder_counts_to_degs(encoder_counts());
+}
+
+int encoder_counts_to_degs(int counts) {
+  return (counts - 32768) * 360 / 1792;
 }
 
 void encoder_reset(void) {
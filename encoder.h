@@ -5,6 +5,8 @@
 
 void encoder_init(void);
 int encoder_counts(void);
+int encoder_degs(void);
+int encoder_counts_to_degs(int counts);
 void encoder_reset(void);
 
 #endif // ENCODER__H__
@@ -0,0 +1,92 @@
+#include "fresp.h"
+#include <math.h>
+
+// Stepped-sine frequency response. The reference is offset + amp*sin(phase)
+// from a Q15 table, with the phase kept in a 32 bit accumulator so any test
+// frequency can be generated without drift. After the loop has settled, the
+// reference and the response are both correlated against sin and cos of the
+// phase over a whole number of periods (a single-bin DFT), so only four sums
+// have to be kept per frequency.
+#define SINE_BITS 8                         // 256 entry sine table
+#define SINE_SIZE (1 << SINE_BITS)
+
+static short sine[SINE_SIZE];               // one period of sin, Q15
+static unsigned int phase, phase_inc;       // phase accumulator, full circle = 2^32
+static int amp, offset;                     // reference amplitude and offset
+static int settle, measure;                 // samples left to settle and to measure
+static long long ref_sin, ref_cos;          // reference correlations
+static long long resp_sin, resp_cos;        // response correlations
+
+void fresp_init(void){
+  int i;
+  for (i = 0; i < SINE_SIZE; i++){
+    sine[i] = (short)(32767.0 * sin(2.0 * M_PI * i / SINE_SIZE));
+  }
+}
+
+void fresp_start(float freq, float fs, int a, int off){
+  float period;
+  int cycles;
+
+  // A frequency <= 0 would never finish; a large amplitude would overflow fresp_ref():
+  if (freq < FRESP_MIN_FREQ){freq = FRESP_MIN_FREQ;}
+  if (a < 0){a = -a;}
+  if (a > FRESP_MAX_AMP){a = FRESP_MAX_AMP;}
+  period = fs / freq;                       // samples per period
+
+  // Settle for two periods (at least 0.1 s), then measure over whole periods
+  // covering at least 0.2 s:
+  cycles = (int)ceilf(0.2 * fs / period);
+  if (cycles < 1){cycles = 1;}
+  settle = (int)(2 * period + 0.1 * fs);
+  measure = (int)(cycles * period + 0.5);
+
+  phase = 0;
+  phase_inc = (unsigned int)(freq / fs * 4294967296.0);
+  amp = a;
+  offset = off;
+  ref_sin = 0;
+  ref_cos = 0;
+  resp_sin = 0;
+  resp_cos = 0;
+}
+
+int fresp_ref(void){
+  return offset + ((amp * sine[phase >> (32 - SINE_BITS)]) >> 15);
+}
+
+int fresp_sample(int y){
+  int idx = phase >> (32 - SINE_BITS);
+  int s = sine[idx];
+  int c = sine[(idx + SINE_SIZE/4) & (SINE_SIZE - 1)];
+  int r = fresp_ref() - offset;
+
+  if (settle > 0){
+    settle--;
+  }
+  else if (measure > 0){
+    y = y - offset;
+    ref_sin += r * s;
+    ref_cos += r * c;
+    resp_sin += y * s;
+    resp_cos += y * c;
+    measure--;
+  }
+  phase += phase_inc;
+  return (settle == 0) && (measure == 0);
+}
+
+void fresp_result(float *gain, float *phase_deg){
+  // For x = A*sin(phase + theta): sum x*sin ~ cos(theta), sum x*cos ~ sin(theta)
+  float ref_mag = sqrtf((float)ref_sin * ref_sin + (float)ref_cos * ref_cos);
+  float resp_mag = sqrtf((float)resp_sin * resp_sin + (float)resp_cos * resp_cos);
+  float ph;
+
+  ph = atan2f(resp_cos, resp_sin) - atan2f(ref_cos, ref_sin);
+  ph = ph * 180.0 / M_PI;
+  if (ph > 180.0){ph -= 360.0;}
+  if (ph <= -180.0){ph += 360.0;}
+
+  *gain = (ref_mag > 0) ? resp_mag / ref_mag : 0;
+  *phase_deg = ph;
+}
@@ -0,0 +1,16 @@
+#ifndef FRESP__H__
+#define FRESP__H__
+
+#include <xc.h>                     // processor SFR definitions
+
+#define FRESP_MAX_PTS 50            // max number of test frequencies in one sweep
+#define FRESP_MIN_FREQ 0.1          // lowest test frequency (Hz)
+#define FRESP_MAX_AMP 2000          // max test amplitude (mA or deg); keeps amp*sine inside an int
+
+void fresp_init(void);              // build the sine table
+void fresp_start(float freq, float fs, int amp, int offset);  // set up one test frequency
+int fresp_ref(void);                // reference sample for this tick
+int fresp_sample(int y);            // correlate response, advance phase; 1 when finished
+void fresp_result(float *gain, float *phase_deg);  // gain and phase (deg) of the response
+
+#endif // FRESP__H__
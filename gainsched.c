@@ -0,0 +1,88 @@
+#include "gainsched.h"
+#include <stdlib.h>
+
+// Each loop has a table of gain scales, one entry per breakpoint, with the
+// breakpoints evenly spaced 2^shift units of |error| apart (mA for the
+// current loop, deg for the position loop). The scales multiply the 'g'/'i'
+// gains, so a single entry table of 1.0 gives the plain fixed gains. Unused
+// entries repeat the last one, so the lookup never needs to know n and
+// always does the same two-point interpolation.
+typedef struct {
+  int n;                            // # of breakpoints uploaded
+  int shift;                        // log2 of breakpoint spacing
+  Gs_scale pt[GS_MAX_PTS];          // scales at |e| = 0, 2^shift, 2*2^shift, ...
+} Gs_table;
+
+static Gs_table tables[2];
+
+static int to_q8(float x){
+  if (x < 0){x = 0;}
+  if (x > 64){x = 64;}              // keep products inside an int
+  return (int)(x * GS_ONE + 0.5);
+}
+
+void gs_init(void){
+  const float one = 1.0;
+  gs_set_table(GS_CURRENT, 1, 0, &one, &one, &one);
+  gs_set_table(GS_POSITION, 1, 0, &one, &one, &one);
+}
+
+int gs_set_table(Gs_loop loop, int n, int shift, const float kp[], const float ki[], const float kd[]){
+  Gs_table t;
+  int i, j;
+
+  if ((n < 1) || (n > GS_MAX_PTS) || (shift < 0) || (shift > GS_MAX_SHIFT)){
+    return 0;
+  }
+  t.n = n;
+  t.shift = shift;
+  for (i = 0; i < GS_MAX_PTS; i++){
+    j = (i < n) ? i : n - 1;
+    t.pt[i].kp = to_q8(kp[j]);
+    t.pt[i].ki = to_q8(ki[j]);
+    t.pt[i].kd = to_q8(kd[j]);
+  }
+
+  tables[loop] = t;                 // caller keeps the ISRs off while this is copied
+  return 1;
+}
+
+int gs_get_table(Gs_loop loop, int *shift, float kp[], float ki[], float kd[]){
+  int i;
+  for (i = 0; i < tables[loop].n; i++){
+    kp[i] = (float)tables[loop].pt[i].kp / GS_ONE;
+    ki[i] = (float)tables[loop].pt[i].ki / GS_ONE;
+    kd[i] = (float)tables[loop].pt[i].kd / GS_ONE;
+  }
+  *shift = tables[loop].shift;
+  return tables[loop].n;
+}
+
+Gs_scale gs_lookup(Gs_loop loop, int e){
+  const Gs_table *t = &tables[loop];
+  unsigned int x = abs(e);
+  unsigned int idx = x >> t->shift;
+  int frac = x & ((1 << t->shift) - 1);     // position between breakpoints, Q(shift)
+  const Gs_scale *a, *b;
+  Gs_scale s;
+
+  // Past the last breakpoint, hold its value:
+  if (idx > GS_MAX_PTS - 2){
+    idx = GS_MAX_PTS - 2;
+    frac = 1 << t->shift;
+  }
+  a = &t->pt[idx];
+  b = &t->pt[idx + 1];
+  s.kp = a->kp + (((b->kp - a->kp) * frac) >> t->shift);
+  s.ki = a->ki + (((b->ki - a->ki) * frac) >> t->shift);
+  s.kd = a->kd + (((b->kd - a->kd) * frac) >> t->shift);
+  return s;
+}
+
+// The part of e*q8 that doesn't make a whole unit is carried in *frac (Q8)
+// to the next call, so small errors still integrate at a low Ki scale:
+int gs_integrate(volatile int *frac, int e, int q8){
+  int acc = *frac + e * q8;
+  *frac = acc % GS_ONE;
+  return acc / GS_ONE;
+}
@@ -0,0 +1,26 @@
+#ifndef GAINSCHED__H__
+#define GAINSCHED__H__
+
+#include <xc.h>                     // processor SFR definitions
+
+#define GS_MAX_PTS 8                // max breakpoints per gain table
+#define GS_MAX_SHIFT 10             // max breakpoint spacing is 2^10 units of |error|
+#define GS_ONE 256                  // gain scale of 1.0 (Q8)
+#define GS_SCALED(gain, q8) ((gain) * ((float)(q8) * (1.0f / GS_ONE)))   // gain times a Q8 scale
+
+typedef enum {GS_CURRENT=0, GS_POSITION=1} Gs_loop;
+
+// Gain scales (Q8) for Kp, Ki and Kd, looked up from the size of the error.
+// The Ki scale goes on each integral increment (gs_integrate), not on the
+// sum, so the integral term does not jump when the error crosses a breakpoint:
+typedef struct {
+  int kp, ki, kd;
+} Gs_scale;
+
+void gs_init(void);                                   // single entry tables, all scales 1.0
+int gs_set_table(Gs_loop loop, int n, int shift, const float kp[], const float ki[], const float kd[]);  // 0 if rejected
+int gs_get_table(Gs_loop loop, int *shift, float kp[], float ki[], float kd[]);  // returns # entries
+Gs_scale gs_lookup(Gs_loop loop, int e);              // interpolated scales for error e
+int gs_integrate(volatile int *frac, int e, int q8);  // whole units of e*q8 to add to an integral
+
+#endif // GAINSCHED__H__
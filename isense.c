@@ -12,9 +12,10 @@ void adc_init(void) {
 }
 
 unsigned int adc_read(void) {
+  unsigned int start;
   AD1CON1bits.SAMP = 1; // start sampling (manual)
-  _CP0_SET_COUNT(0);
-  while (_CP0_GET_COUNT() < SAMPLE_TIME){
+  start = _CP0_GET_COUNT();   // core timer keeps running, so it can time other code
+  while (_CP0_GET_COUNT() - start < SAMPLE_TIME){
     ; // sample for more than 25*SAMPLE_TIME ns
   }
   while (!AD1CON1bits.DONE){
@@ -24,10 +25,11 @@ unsigned int adc_read(void) {
 }
 
 int read_cur_amps(void){
-  unsigned int cur_counts;
-  int cur_amps;
+  return isense_counts_to_ma(adc_read());
+}
 
-  cur_counts = adc_read();
+int isense_counts_to_ma(unsigned int cur_counts){
+  int cur_amps;
   cur_amps = 2.04 * cur_counts - 1024;    // from calibration
   return cur_amps;
 }
\ No newline at end of file
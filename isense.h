@@ -6,5 +6,6 @@
 void adc_init(void);         		 // initialize ADC
 unsigned int adc_read(void); 		 // read ADC count
 int read_cur_amps(void);	 		 // read current (mA)
+int isense_counts_to_ma(unsigned int cur_counts);  // convert ADC counts to current (mA)
 
 #endif // ISENSE__H__
@@ -1,31 +1,47 @@
 ///////////////////////////
 // Imports and constants //
 ///////////////////////////
+#include <stdint.h>        // int16_t for the sample buffers
+#include <math.h>          // powf for the frequency sweep
 #include "NU32.h"          // config bits, constants, funcs for startup and UART
 #include "encoder.h"
 #include "utilities.h"     
 #include "isense.h"   
 #include "currentcontrol.h"
 #include "positioncontrol.h" 
+#include "bench.h"
+#include "fresp.h"
+#include "gainsched.h"
 
 #define BUF_SIZE 200       // max UART message length
-#define MAXSAMPS 2000      // max number of samples in ref trajectory
+#define ITEST_SAMPS 100    // number of samples in ITEST
+
+// RAM_BUFFER_BYTES is set by the Makefile from the RAM left over after the reserve
+// for other globals, heap and stack; it holds REFtraj + SENtraj.
+#ifndef RAM_BUFFER_BYTES
+#define RAM_BUFFER_BYTES 98304
+#endif
+#define MAXSAMPS ((int)(RAM_BUFFER_BYTES / (2 * sizeof(int16_t))))   // max number of samples in ref trajectory
+
+// Sample buffers are not volatile; ISR and main loop hand them over at MEMORY_BARRIER().
+// They live in .ram_buffers, which the linker script leaves uninitialized (NOLOAD).
+#define RAM_BUFFER __attribute__((section(".ram_buffers")))
 
 //////////////////////
 // Global variables //
 //////////////////////
-static volatile int dutycycle = 0;                          // duty cycle [-100 to 100] for PWM
 static volatile int ang_target = 0;                         // target position (deg)
 static volatile int u_pos = 0;                              // position control signal (= current control ref)
-static volatile int SENarray[100];                          // array of measured I for ITEST
-static volatile int REFarray[100];                          // ref array for ITEST
+static int16_t SENarray[ITEST_SAMPS] RAM_BUFFER;            // array of measured I for ITEST
+static int16_t REFarray[ITEST_SAMPS] RAM_BUFFER;            // ref array for ITEST
 static volatile float KpI = 0.75, KiI = 0.05;               // current control gains
 static volatile float KpP = 150.0, KiP = 0.0, KdP = 5000;   // position control gains
 static volatile int EIint = 0, EPint = 0;                   // integral (sum) of control error
+static volatile int EIfrac = 0, EPfrac = 0;                 // integral remainders below one unit (Q8)
 static volatile int e_pos_prev = 0;                         // previous position error (for D control)
 static volatile int num_samples = 0;                        // # of samples in ref trajectory
-static volatile int REFtraj[MAXSAMPS];                      // ref trajectory for position control
-static volatile int SENtraj[MAXSAMPS];                      // measured trajectory for position control
+static int16_t REFtraj[MAXSAMPS] RAM_BUFFER;                // ref trajectory for position control
+static int16_t SENtraj[MAXSAMPS] RAM_BUFFER;                // measured trajectory for position control
 
 ////////////////////////////////
 // Interrupt Service Routines //
@@ -34,34 +50,10 @@ void __ISR(_TIMER_2_VECTOR, IPL5SOFT) CurrentController(void){
   static int counter = 0;   // initialize counter once
   int sensed_cur;           // sensed current in mA
   int e, u, unew;
+  Gs_scale sc;              // scheduled gain scales
 
+  // Timer2 is gated off in IDLE and PWM (see set_mode), so those never get here
   switch (get_mode()) {
-    case IDLE:
-    {
-      EIint = 0;
-      dutycycle = 0;
-      OC1RS = 0;            // 0 duty cycle => H-bridge in brake mode
-      break;
-    }
-
-    case PWM:
-    {
-      if (dutycycle < 0){
-        LATDbits.LATD8 = 1;    // output = high => motor in reverse
-      }
-      else{
-        LATDbits.LATD8 = 0;    // output = low => motor in forward
-      }
-
-      // Cap to 100% if user input magnitude greater than a threshold:
-      if (abs(dutycycle) > 100){
-        dutycycle = 100;
-      }
-      
-      OC1RS = (unsigned int)((abs(dutycycle)/100.0)*PR3);
-      break; 
-    }
-
     case ITEST:
     {
       // Reference signal:
@@ -79,8 +71,9 @@ void __ISR(_TIMER_2_VECTOR, IPL5SOFT) CurrentController(void){
       //   EIint = EIint + e;
       // }
 
-      EIint = EIint + e;
-      u = KpI*e + KiI*EIint;
+      sc = gs_lookup(GS_CURRENT, e);
+      EIint = EIint + gs_integrate(&EIfrac, e, sc.ki);
+      u = current_pi(e, EIint, GS_SCALED(KpI, sc.kp), KiI);
       if (u < 0){
         LATDbits.LATD8 = 1;    // output = high => motor in reverse
       }
@@ -100,27 +93,61 @@ void __ISR(_TIMER_2_VECTOR, IPL5SOFT) CurrentController(void){
       REFarray[counter] = ref;
 
       counter++;
-      if (counter == 100){
+      if (counter == ITEST_SAMPS){
         EIint = 0;     // reset integral of control error
+        EIfrac = 0;
         counter = 0;   // reset counter
+        MEMORY_BARRIER();   // samples stored before main sees IDLE
+        set_mode(IDLE);
+      }
+      break;
+    }
+
+    case IFRESP:
+    {
+      // PI current control of the test sine:
+      int ref = fresp_ref();
+      sensed_cur = read_cur_amps();
+      e = ref - sensed_cur;
+
+      sc = gs_lookup(GS_CURRENT, e);
+      EIint = EIint + gs_integrate(&EIfrac, e, sc.ki);
+      u = current_pi(e, EIint, GS_SCALED(KpI, sc.kp), KiI);
+      if (u < 0){
+        LATDbits.LATD8 = 1;    // output = high => motor in reverse
+      }
+      else{
+        LATDbits.LATD8 = 0;    // output = low => motor in forward
+      }
+      unew = abs(u);
+      if (unew > 100){unew = 100;}
+
+      OC1RS = (unsigned int)(((float)(unew)/100.0)*PR3);
+
+      // Correlate the response; stop when this frequency is done:
+      if (fresp_sample(sensed_cur)){
+        EIint = 0;     // reset integral of control error
+        EIfrac = 0;
         set_mode(IDLE);
       }
       break;
     }
 
     case HOLD:
+    case PFRESP:               // position loop runs the test, current loop as in HOLD
     {
       // PI current control signal:
       sensed_cur = read_cur_amps();
       e = u_pos - sensed_cur;
 
-      EIint = EIint + e;
+      sc = gs_lookup(GS_CURRENT, e);
+      EIint = EIint + gs_integrate(&EIfrac, e, sc.ki);
       
       // if (EIint < 1000){
       //   EIint = EIint + e;
       // }
 
-      u = KpI*e + KiI*EIint;
+      u = current_pi(e, EIint, GS_SCALED(KpI, sc.kp), KiI);
       if (u < 0){
         LATDbits.LATD8 = 1;    // output = high => motor in reverse
       }
@@ -140,13 +167,14 @@ void __ISR(_TIMER_2_VECTOR, IPL5SOFT) CurrentController(void){
       sensed_cur = read_cur_amps();
       e = u_pos - sensed_cur;
 
-      EIint = EIint + e;
+      sc = gs_lookup(GS_CURRENT, e);
+      EIint = EIint + gs_integrate(&EIfrac, e, sc.ki);
       
       // if EIint < 1000{
       //   EIint = EIint + e;
       // }
 
-      u = KpI*e + KiI*EIint;
+      u = current_pi(e, EIint, GS_SCALED(KpI, sc.kp), KiI);
       if (u < 0){
         LATDbits.LATD8 = 1;    // output = high => motor in reverse
       }
@@ -172,34 +200,26 @@ void __ISR(_TIMER_2_VECTOR, IPL5SOFT) CurrentController(void){
 
 void __ISR(_TIMER_4_VECTOR, IPL7SOFT) PositionController(void){
   static int ctr = 0;          // initialize counter once
+  int sensed_counts;           // encoder counts
   int sensed_ang, ref_ang;     // angles in deg
   int e_pos, u_pos_proto;
+  Gs_scale sc;                 // scheduled gain scales
 
+  // Timer4 only runs in HOLD, TRACK and PFRESP (see set_mode)
   switch (get_mode()) {
-    case IDLE:
-    {
-      break;
-    }
-
-    case PWM:
-    {
-      break;
-    }
-    
-    case ITEST:
-    {
-      break;
-    }
-    
     case HOLD:
     {
-      sensed_ang = encoder_degs();
+      sensed_counts = encoder_counts();
+      sensed_ang = encoder_counts_to_degs(sensed_counts);
       ref_ang = ang_target;
       e_pos = ref_ang - sensed_ang;
-      EPint = EPint + e_pos;
+      sc = gs_lookup(GS_POSITION, e_pos);
+      EPint = EPint + gs_integrate(&EPfrac, e_pos, sc.ki);
 
-      // position control signal:
-      u_pos_proto = KpP*e_pos + KiP*EPint + KdP*(e_pos - e_pos_prev);
+      // position control signal, plus load estimate fed forward:
+      u_pos_proto = position_pid(e_pos, EPint, e_pos - e_pos_prev,
+                                 GS_SCALED(KpP, sc.kp), KiP, GS_SCALED(KdP, sc.kd));
+      u_pos_proto = u_pos_proto + dob_update(u_pos, sensed_counts);
       if (u_pos_proto > 300){u_pos = 300;}
       else if (u_pos_proto < -300){u_pos = -300;}
       else u_pos = u_pos_proto;
@@ -209,13 +229,17 @@ void __ISR(_TIMER_4_VECTOR, IPL7SOFT) PositionController(void){
 
     case TRACK:
     {
-      sensed_ang = encoder_degs();
+      sensed_counts = encoder_counts();
+      sensed_ang = encoder_counts_to_degs(sensed_counts);
       ref_ang = REFtraj[ctr];
       e_pos = ref_ang - sensed_ang;
-      EPint = EPint + e_pos;
+      sc = gs_lookup(GS_POSITION, e_pos);
+      EPint = EPint + gs_integrate(&EPfrac, e_pos, sc.ki);
 
-      // position control signal:
-      u_pos_proto = KpP*e_pos + KiP*EPint + KdP*(e_pos - e_pos_prev);
+      // position control signal, plus load estimate fed forward:
+      u_pos_proto = position_pid(e_pos, EPint, e_pos - e_pos_prev,
+                                 GS_SCALED(KpP, sc.kp), KiP, GS_SCALED(KdP, sc.kd));
+      u_pos_proto = u_pos_proto + dob_update(u_pos, sensed_counts);
       if (u_pos_proto > 300){u_pos = 300;}
       else if (u_pos_proto < -300){u_pos = -300;}
       else u_pos = u_pos_proto;
@@ -228,6 +252,32 @@ void __ISR(_TIMER_4_VECTOR, IPL7SOFT) PositionController(void){
       if (ctr == num_samples){
         ang_target = REFtraj[num_samples-1];  // set last ref as target for HOLD
         ctr = 0;                              // reset counter
+        MEMORY_BARRIER();                     // samples stored before main sees HOLD
+        set_mode(HOLD);
+      }
+      break;
+    }
+
+    case PFRESP:
+    {
+      sensed_counts = encoder_counts();
+      sensed_ang = encoder_counts_to_degs(sensed_counts);
+      ref_ang = fresp_ref();
+      e_pos = ref_ang - sensed_ang;
+      sc = gs_lookup(GS_POSITION, e_pos);
+      EPint = EPint + gs_integrate(&EPfrac, e_pos, sc.ki);
+
+      // position control signal, plus load estimate fed forward:
+      u_pos_proto = position_pid(e_pos, EPint, e_pos - e_pos_prev,
+                                 GS_SCALED(KpP, sc.kp), KiP, GS_SCALED(KdP, sc.kd));
+      u_pos_proto = u_pos_proto + dob_update(u_pos, sensed_counts);
+      if (u_pos_proto > 300){u_pos = 300;}
+      else if (u_pos_proto < -300){u_pos = -300;}
+      else u_pos = u_pos_proto;
+      e_pos_prev = e_pos;
+
+      // Correlate the response; hold at ang_target when this frequency is done:
+      if (fresp_sample(sensed_ang)){
         set_mode(HOLD);
       }
       break;
@@ -254,14 +304,18 @@ int main()
   NU32_LED2 = 1;        
   __builtin_disable_interrupts();
   encoder_init();         // initialize SPI4 for encoder
-  set_mode(IDLE);         // initialize PIC32 to IDLE mode
   adc_init();             // initialize ADC
   currentcontrol_init();  // initialize peripherals for current control
   positioncontrol_init(); // initialize timer4 for position control
+  set_mode(IDLE);         // initialize PIC32 to IDLE mode (both control loops gated off)
+  fresp_init();           // build sine table for frequency response tests
+  gs_init();              // no gain scheduling: 'g'/'i' gains at every error size
+  wait_init();            // UART3 RX priority, so a command can end the main loop's WAIT
   __builtin_enable_interrupts();
 
   while(1)
   {
+    wait_for_command();              // sleep until the client sends something
     NU32_ReadUART3(buffer,BUF_SIZE); // we expect the next character to be a menu command
     NU32_LED2 = 1;                   // clear the error LED
     switch (buffer[0]) {
@@ -305,9 +359,11 @@ int main()
 
       case 'f':                      // set PWM (-100 to 100)
       {
+        int dutycycle = 0;
         NU32_ReadUART3(buffer, BUF_SIZE);
         sscanf(buffer, "%d", &dutycycle);
-        set_mode(PWM);
+        set_mode(PWM);               // no control loop runs in PWM, so apply the duty here
+        currentcontrol_set_pwm(dutycycle);
         break;
       }
 
@@ -357,20 +413,21 @@ int main()
 
       case 'k':                      // test current control
       {
-        // Switch to ITEST mode:
+        // Switch to ITEST mode, with no integral left over from an earlier loop:
         __builtin_disable_interrupts();
+        EIint = 0;
+        EIfrac = 0;
         set_mode(ITEST);
         __builtin_enable_interrupts();
-        while (get_mode()==ITEST){
-          ;   // do nothing
-        }
+        wait_while_mode(ITEST);
+        MEMORY_BARRIER();   // read samples only after ITEST is over
 
         // Send plot data to MATLAB:
         __builtin_disable_interrupts();       
-        sprintf(buffer, "%d\r\n", 100);
+        sprintf(buffer, "%d\r\n", ITEST_SAMPS);
         NU32_WriteUART3(buffer);
         int idx = 0;
-        for (idx=0; idx<100; idx++){
+        for (idx=0; idx<ITEST_SAMPS; idx++){
           sprintf(buffer, "%d %d\r\n", REFarray[idx], SENarray[idx]);
           NU32_WriteUART3(buffer);
         }
@@ -382,9 +439,12 @@ int main()
       {
         __builtin_disable_interrupts();
         encoder_reset();
+        dob_reset();
         e_pos_prev = 0;
         EPint = 0;
+        EPfrac = 0;
         EIint = 0;
+        EIfrac = 0;
         u_pos = 0;
         NU32_ReadUART3(buffer, BUF_SIZE);
         sscanf(buffer, "%d", &ang_target);
@@ -395,31 +455,59 @@ int main()
 
       case 'm':                      // load step trajectory
       {
+        // Interrupts stay on while the samples arrive, so HOLD keeps running;
+        // only TRACK reads REFtraj, and that can't run until 'o'.
+        int i, n = 0, ok, ref_deg;
+        sprintf(buffer, "%d\r\n", MAXSAMPS);   // tell the client how many samples fit
+        NU32_WriteUART3(buffer);
         NU32_ReadUART3(buffer, BUF_SIZE);
-        __builtin_disable_interrupts();
-        int i, ref_deg;
-        sscanf(buffer, "%d", &num_samples);
-        for (i = 0; i < num_samples; i++){
+        sscanf(buffer, "%d", &n);
+        ok = (n > 0) && (n <= MAXSAMPS);   // else keep the old trajectory
+        for (i = 0; i < n; i++){
           NU32_ReadUART3(buffer, BUF_SIZE);
-          sscanf(buffer, "%d", &ref_deg);
-          REFtraj[i] = ref_deg;
+          if (ok){
+            sscanf(buffer, "%d", &ref_deg);
+            REFtraj[i] = ref_deg;
+          }
+        }
+        if (ok){
+          MEMORY_BARRIER();   // trajectory stored before the ISR can read it
+          __builtin_disable_interrupts();
+          num_samples = n;
+          __builtin_enable_interrupts();
+        }
+        else{
+          NU32_LED2 = 0;      // turn on LED2 to indicate an error
         }
-        __builtin_enable_interrupts();        
         break;
       }
 
       case 'n':                      // load cubic trajectory
       {
+        // Interrupts stay on while the samples arrive, so HOLD keeps running;
+        // only TRACK reads REFtraj, and that can't run until 'o'.
+        int i, n = 0, ok, ref_deg;
+        sprintf(buffer, "%d\r\n", MAXSAMPS);   // tell the client how many samples fit
+        NU32_WriteUART3(buffer);
         NU32_ReadUART3(buffer, BUF_SIZE);
-        __builtin_disable_interrupts();
-        int i, ref_deg;
-        sscanf(buffer, "%d", &num_samples);
-        for (i = 0; i < num_samples; i++){
+        sscanf(buffer, "%d", &n);
+        ok = (n > 0) && (n <= MAXSAMPS);   // else keep the old trajectory
+        for (i = 0; i < n; i++){
           NU32_ReadUART3(buffer, BUF_SIZE);
-          sscanf(buffer, "%d", &ref_deg);
-          REFtraj[i] = ref_deg;
+          if (ok){
+            sscanf(buffer, "%d", &ref_deg);
+            REFtraj[i] = ref_deg;
+          }
+        }
+        if (ok){
+          MEMORY_BARRIER();   // trajectory stored before the ISR can read it
+          __builtin_disable_interrupts();
+          num_samples = n;
+          __builtin_enable_interrupts();
+        }
+        else{
+          NU32_LED2 = 0;      // turn on LED2 to indicate an error
         }
-        __builtin_enable_interrupts();        
         break;
       }
 
@@ -427,15 +515,19 @@ int main()
       {
         __builtin_disable_interrupts();
         encoder_reset();
+        dob_reset();
         e_pos_prev = 0;
         EPint = 0;
+        EPfrac = 0;
         EIint = 0;
+        EIfrac = 0;
         u_pos = 0;
         __builtin_enable_interrupts();
 
         // Track, then hold:
         set_mode(TRACK);
-        while (get_mode()==TRACK){;}
+        wait_while_mode(TRACK);
+        MEMORY_BARRIER();   // read samples only after TRACK is over
 
         // Send plot data to MATLAB:
         // __builtin_disable_interrupts();       
@@ -468,7 +560,131 @@ int main()
         NU32_WriteUART3(buffer);
         break;
       }
+
+      case 's':                      // set disturbance observer bandwidth (Hz) and plant inverse
+      {
+        int bw = 0, inv = DOB_INV_GAIN;
+        NU32_ReadUART3(buffer, BUF_SIZE);
+        sscanf(buffer, "%d %d", &bw, &inv);
+        __builtin_disable_interrupts();
+        dob_set_bandwidth(bw);
+        dob_set_inv_gain(inv);
+        dob_reset();
+        __builtin_enable_interrupts();
+        break;
+      }
+
+      case 't':                      // get disturbance observer bandwidth (Hz) and plant inverse
+      {
+        sprintf(buffer, "%d\r\n", dob_get_bandwidth());
+        NU32_WriteUART3(buffer);
+        sprintf(buffer, "%d\r\n", dob_get_inv_gain());
+        NU32_WriteUART3(buffer);
+        break;
+      }
+
+      case 'u':                      // benchmark control kernels
+      {
+        int iters;
+        NU32_ReadUART3(buffer, BUF_SIZE);
+        sscanf(buffer, "%d", &iters);
+        set_mode(IDLE);              // loops off, H-bridge braked
+        bench_run(iters);
+        break;
+      }
+
+      case 'v':                      // measure frequency response (Bode)
+      {
+        int loop = 0, amp = 0, npts = 0, i;
+        float fmin = 0, fmax = 0, fs, f, gain, phase;
+        Mode_datatype test;
+        NU32_ReadUART3(buffer, BUF_SIZE);
+        sscanf(buffer, "%d %d %f %f %d", &loop, &amp, &fmin, &fmax, &npts);
+
+        // loop 0 = current (amp in mA), 1 = position (amp in deg):
+        test = loop ? PFRESP : IFRESP;
+        fs = loop ? POSITION_LOOP_FREQ : CURRENT_LOOP_FREQ;
+        if (npts < 1){npts = 1;}
+        if (npts > FRESP_MAX_PTS){npts = FRESP_MAX_PTS;}
+        if (fmax > fs/4){fmax = fs/4;}
+        if (fmax < FRESP_MIN_FREQ){   // nothing to sweep: send an empty table
+          NU32_LED2 = 0;             // turn on LED2 to indicate an error
+          NU32_WriteUART3("0\r\n");
+          break;
+        }
+        if (fmin < FRESP_MIN_FREQ){fmin = FRESP_MIN_FREQ;}
+        if (fmin > fmax){fmin = fmax;}
+
+        __builtin_disable_interrupts();
+        encoder_reset();
+        dob_reset();
+        e_pos_prev = 0;
+        EPint = 0;
+        EPfrac = 0;
+        EIint = 0;
+        EIfrac = 0;
+        u_pos = 0;
+        ang_target = 0;           // position test oscillates about, and ends holding, 0 deg
+        set_mode(loop ? HOLD : IDLE);
+        __builtin_enable_interrupts();
+
+        // One (frequency, gain, phase) line per test frequency, log spaced:
+        sprintf(buffer, "%d\r\n", npts);
+        NU32_WriteUART3(buffer);
+        for (i = 0; i < npts; i++){
+          f = (npts > 1) ? fmin * powf(fmax/fmin, (float)i/(npts - 1)) : fmin;
+          __builtin_disable_interrupts();
+          fresp_start(f, fs, amp, 0);
+          set_mode(test);
+          __builtin_enable_interrupts();
+          wait_while_mode(test);
+          MEMORY_BARRIER();   // read the sums only after the test is over
+
+          fresp_result(&gain, &phase);
+          sprintf(buffer, "%f %f %f\r\n", f, gain, phase);
+          NU32_WriteUART3(buffer);
+        }
+        break;
+      }
       
+      case 'w':                      // set gain schedule table
+      {
+        int loop = 0, n = 0, shift = -1, i, ok, bad = 0;   // a failed parse leaves values gs_set_table rejects
+        float kp[GS_MAX_PTS], ki[GS_MAX_PTS], kd[GS_MAX_PTS];
+        NU32_ReadUART3(buffer, BUF_SIZE);
+        sscanf(buffer, "%d %d %d", &loop, &n, &shift);
+        for (i = 0; i < n; i++){     // read every line the client sends, keep the first GS_MAX_PTS
+          NU32_ReadUART3(buffer, BUF_SIZE);
+          if (i < GS_MAX_PTS && sscanf(buffer, "%f %f %f", &kp[i], &ki[i], &kd[i]) != 3){bad = 1;}
+        }
+        ok = 0;
+        if (!bad){
+          __builtin_disable_interrupts();
+          ok = gs_set_table(loop ? GS_POSITION : GS_CURRENT, n, shift, kp, ki, kd);
+          __builtin_enable_interrupts();
+        }
+        if (!ok){
+          NU32_LED2 = 0;             // turn on LED2 to indicate an error
+        }
+        break;
+      }
+
+      case 'x':                      // get gain schedule table
+      {
+        int loop = 0, n, shift, i;   // a failed parse dumps the current table
+        float kp[GS_MAX_PTS], ki[GS_MAX_PTS], kd[GS_MAX_PTS];
+        NU32_ReadUART3(buffer, BUF_SIZE);
+        sscanf(buffer, "%d", &loop);
+        n = gs_get_table(loop ? GS_POSITION : GS_CURRENT, &shift, kp, ki, kd);
+        sprintf(buffer, "%d %d\r\n", n, shift);
+        NU32_WriteUART3(buffer);
+        for (i = 0; i < n; i++){
+          sprintf(buffer, "%f %f %f\r\n", kp[i], ki[i], kd[i]);
+          NU32_WriteUART3(buffer);
+        }
+        break;
+      }
+
       default:
       {
         NU32_LED2 = 0;  // turn on LED2 to indicate an error
@@ -1,4 +1,20 @@
 #include "positioncontrol.h"
+#include <math.h>
+
+// Disturbance observer state. The load is estimated as the current that would
+// produce the difference between the commanded and the measured acceleration.
+// With the current held over each tick, th[k] - 2*th[k-1] + th[k-2] responds
+// to the average of the last two commands, so
+//   d_raw = (u[k-1] + u[k-2])/2 - inv_gain * (th[k] - 2*th[k-1] + th[k-2])
+// which is smoothed by a first order low pass filter with gain alpha (Q15).
+// The estimate is kept in Q16 mA so small corrections are not lost.
+static volatile int dob_bw = 0;                // observer bandwidth (Hz)
+static volatile int dob_alpha = 0;             // filter gain 1-exp(-2*pi*bw*Ts), Q15
+static volatile int dob_inv_gain = DOB_INV_GAIN;   // plant inverse, mA per (count/tick^2)
+static int dob_th1 = 0, dob_th2 = 0;           // previous two encoder counts
+static int dob_u1 = 0;                         // command before the last one, u[k-2] (mA)
+static int dob_hist = 0;                       // # of valid samples in history
+static long long dob_est = 0;                  // load estimate (mA), Q16
 
 void positioncontrol_init(void){
   // Initialize Timer4 interrupt for 200 Hz position control loop //
@@ -7,6 +23,75 @@ void positioncontrol_init(void){
   TMR4 = 0;                // initial Timer4 count is 0
   IPC4bits.T4IP = 7;       // priority for Timer4 interrupt
   IFS0bits.T4IF = 0;       // clear Timer4 interrupt flag
-  IEC0bits.T4IE = 1;       // enable Timer4 interrupt
+  IEC0bits.T4IE = 0;       // Timer4 interrupt is armed by set_mode() when a mode needs it
   T4CONbits.ON = 1;        // turn on Timer4    
-}
\ No newline at end of file
+}
+
+// Same scheme as currentcontrol_enable(), for Timer4
+void positioncontrol_enable(int on){
+  if (on && !IEC0bits.T4IE){          // leave a running loop alone
+    TMR4 = 0;                         // full period before the first tick
+    IFS0CLR = _IFS0_T4IF_MASK;        // no stale tick
+    IEC0SET = _IEC0_T4IE_MASK;
+  }
+  else if (!on){
+    IEC0CLR = _IEC0_T4IE_MASK;
+    IFS0CLR = _IFS0_T4IF_MASK;
+  }
+}
+
+int position_pid(int e, int eint, int edot, float kp, float ki, float kd){
+  return kp*e + ki*eint + kd*edot;
+}
+
+void dob_reset(void){
+  dob_th1 = 0;
+  dob_th2 = 0;
+  dob_u1 = 0;
+  dob_hist = 0;
+  dob_est = 0;
+}
+
+void dob_set_bandwidth(int hz){
+  if (hz < 0){hz = 0;}
+  if (hz > DOB_MAX_BW){hz = DOB_MAX_BW;}
+  dob_bw = hz;
+  dob_alpha = (int)(32768.0 * (1.0 - exp(-2.0 * M_PI * hz / POSITION_LOOP_FREQ)));
+}
+
+int dob_get_bandwidth(void){
+  return dob_bw;
+}
+
+void dob_set_inv_gain(int g){
+  if (g < 0){g = 0;}
+  if (g > DOB_MAX_INV_GAIN){g = DOB_MAX_INV_GAIN;}
+  dob_inv_gain = g;
+}
+
+int dob_get_inv_gain(void){
+  return dob_inv_gain;
+}
+
+// u is the command applied over the last tick, u[k-1]
+int dob_update(int u, int counts){
+  int accel, d_raw;
+
+  // Need two past samples before the second difference means anything:
+  if (dob_hist < 2){
+    dob_hist++;
+  }
+  else{
+    accel = counts - 2*dob_th1 + dob_th2;        // counts/tick^2
+    d_raw = (u + dob_u1)/2 - dob_inv_gain*accel; // mA
+    dob_est += (dob_alpha * (((long long)d_raw << 16) - dob_est)) >> 15;
+  }
+  dob_th2 = dob_th1;
+  dob_th1 = counts;
+  dob_u1 = u;
+
+  if (dob_alpha == 0){
+    return 0;
+  }
+  return (int)(dob_est >> 16);
+}
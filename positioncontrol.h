@@ -3,7 +3,27 @@
 
 #include <xc.h>                     // processor SFR definitions
 
+#define POSITION_LOOP_FREQ 200      // position control loop rate (Hz)
+
+#define DOB_MAX_BW 50               // max observer bandwidth (Hz), well below 100 Hz Nyquist
+#define DOB_INV_GAIN 40             // default plant inverse: mA per (count/tick^2) of acceleration
+#define DOB_MAX_INV_GAIN 1000       // max plant inverse accepted from the menu
+
+// Calibrating the plant inverse: with no load and the observer off, hold a
+// constant current u (mA) from rest and read the encoder counts every 5 ms.
+// The inverse is u divided by the average second difference of the counts.
+// Too large a value overstates the inertia and can make HOLD unstable.
+
 void positioncontrol_init(void);    // initialize peripherals for position control
 // void load_trajectory(void);         // load trajectory from client
+void positioncontrol_enable(int on);  // arm (1) or gate off (0) the Timer4 interrupt
+int position_pid(int e, int eint, int edot, float kp, float ki, float kd);  // PID control signal
+
+void dob_reset(void);               // clear disturbance observer state
+void dob_set_bandwidth(int hz);     // set observer bandwidth (Hz), 0 disables it
+int dob_get_bandwidth(void);        // get observer bandwidth (Hz)
+void dob_set_inv_gain(int g);       // set plant inverse, mA per (count/tick^2)
+int dob_get_inv_gain(void);         // get plant inverse
+int dob_update(int u, int counts);  // run observer once per tick, return load estimate (mA)
 
 #endif // POSITIONCONTROL__H__
@@ -0,0 +1,67 @@
+# Report data/bss RAM usage per module from a GNU ld map file.
+#
+#   awk -v budget=<bytes> -f ramreport.awk out.map
+#
+# Only the "Linker script and memory map" part of the map is read, so
+# discarded input sections are not counted. Initialized sections (.data,
+# .sdata) count as data; zeroed or uninitialized ones (.bss, .sbss, COMMON,
+# .ram_buffers) count as bss. Exits with status 1 if data + bss > budget.
+
+function ramkind(sec) {
+  if (sec ~ /^\.s?data($|\.)/) return "data"
+  if (sec ~ /^\.s?bss($|\.)/ || sec ~ /^(COMMON|\.scommon|\.dynbss|\.dynsbss)$/ || sec ~ /^\.ram_buffers($|\.)/) return "bss"
+  return ""
+}
+
+function hex(str,    i, n) {
+  n = 0
+  str = tolower(substr(str, 3))
+  for (i = 1; i <= length(str); i++) n = n * 16 + index("0123456789abcdef", substr(str, i, 1)) - 1
+  return n
+}
+
+function add(sec, size, mod,    kind, n) {
+  kind = ramkind(sec)
+  n = hex(size)
+  if (kind == "" || n == 0) return
+  sub(/.*\//, "", mod)
+  if (!(mod in seen)) { seen[mod] = 1; mods[++nmods] = mod }
+  used[mod, kind] += n
+  total[kind] += n
+}
+
+/^Linker script and memory map/ { inmap = 1; next }
+!inmap { next }
+
+# input section on one line: " .bss  0xa0000010  0x1f40 main.o"
+/^ [^ *]+ +0x[0-9a-fA-F]+ +0x[0-9a-fA-F]+ +[^ ]/ {
+  add($1, $3, $4)
+  pending = ""
+  next
+}
+
+# long section names wrap: " .bss.REFtraj" then "   0xa0000010  0x1f40 main.o"
+/^ [^ *]+$/ { pending = $1; next }
+pending != "" && /^ +0x[0-9a-fA-F]+ +0x[0-9a-fA-F]+ +[^ ]/ {
+  add(pending, $2, $3)
+  pending = ""
+  next
+}
+{ pending = "" }
+
+END {
+  printf "%-32s %8s %8s %8s\n", "module", "data", "bss", "total"
+  for (i = 1; i <= nmods; i++) {
+    m = mods[i]
+    printf "%-32s %8d %8d %8d\n", m, used[m, "data"], used[m, "bss"], used[m, "data"] + used[m, "bss"]
+  }
+  sum = total["data"] + total["bss"]
+  printf "%-32s %8d %8d %8d\n", "TOTAL", total["data"], total["bss"], sum
+  if (budget != "") {
+    printf "RAM budget: %d of %d bytes used\n", sum, budget
+    if (sum > budget + 0) {
+      printf "error: data + bss exceeds RAM budget by %d bytes\n", sum - budget > "/dev/stderr"
+      exit 1
+    }
+  }
+}
@@ -0,0 +1,39 @@
+function results = read_bench(mySerial, outfile, basefile)
+  hdr = fscanf(mySerial,'%d %d');          % first get the number of kernels and iterations
+  nkernels = hdr(1);
+  iters = hdr(2);
+  names = cell(nkernels,1);
+  cycles = zeros(nkernels,1);
+  for i=1:nkernels
+    line = strtrim(fgetl(mySerial));       % "<kernel> <cycles per call>"
+    parts = strsplit(line);
+    names{i} = parts{1};
+    cycles(i) = str2double(parts{2});
+  end
+  results = table(names, cycles, repmat(iters,nkernels,1), ...
+                  'VariableNames', {'kernel','cycles_per_call','iterations'});
+
+  % save results in a machine-readable file:
+  writetable(results, outfile);
+  fprintf('\nBenchmark results (%d iterations, saved to %s):\n', iters, outfile);
+
+  % compare against a saved baseline if there is one; flag >10% slower:
+  base = [];
+  if exist(basefile, 'file')
+    base = readtable(basefile);
+  end
+  for i=1:nkernels
+    fprintf('%-20s %10.1f cycles', names{i}, cycles(i));
+    if ~isempty(base)
+      j = find(strcmp(base.kernel, names{i}));
+      if ~isempty(j) && base.cycles_per_call(j) > 0
+        change = 100*(cycles(i) - base.cycles_per_call(j))/base.cycles_per_call(j);
+        fprintf('  %+6.1f%%', change);
+        if change > 10
+          fprintf('  <-- REGRESSION');
+        end
+      end
+    end
+    fprintf('\n');
+  end
+end
@@ -0,0 +1,18 @@
+function data = read_bode(mySerial)
+  npts = fscanf(mySerial,'%d');           % first get the number of test frequencies
+  data = zeros(npts,3);                   % three values per point: freq, gain, phase
+  for i=1:npts
+    data(i,:) = fscanf(mySerial,'%f %f %f'); % freq in Hz, gain (ratio), phase in deg
+    fprintf('%8.2f Hz  %7.2f dB  %7.1f deg\n', data(i,1), 20*log10(data(i,2)), data(i,3));
+  end
+  subplot(2,1,1);
+  semilogx(data(:,1), 20*log10(data(:,2)), 'o-');
+  grid on;
+  ylabel('Magnitude (dB)');
+  title('Closed loop frequency response');
+  subplot(2,1,2);
+  semilogx(data(:,1), data(:,3), 'o-');
+  grid on;
+  ylabel('Phase (deg)');
+  xlabel('Frequency (Hz)');
+end
@@ -1,11 +1,71 @@
 #include "utilities.h"
+#include <xc.h>
+#include "currentcontrol.h"
+#include "positioncontrol.h"
 
 static volatile Mode_datatype mode;		// declare global var which is the current mode
 
 void set_mode(Mode_datatype m){
+	int cur = (m != IDLE) && (m != PWM);
+	int pos = (m == HOLD) || (m == TRACK) || (m == PFRESP);
+
+	// Only run the control loops this mode needs; an armed loop starts clean.
+	// Loops are gated off before the new mode is published and armed after it,
+	// so neither ISR ever runs in a mode it doesn't handle:
+	if (!cur){currentcontrol_enable(0);}
+	if (!pos){positioncontrol_enable(0);}
 	mode = m;
+	currentcontrol_enable(cur);
+	positioncontrol_enable(pos);
+	if (m == IDLE){
+		currentcontrol_set_pwm(0);		// 0 duty cycle => H-bridge in brake mode
+	}
 }
 
 Mode_datatype get_mode(void){
 	return mode;
-}
\ No newline at end of file
+}
+
+// The two waits below check their condition with interrupts off and then
+// execute WAIT. A pending interrupt still ends WAIT while interrupts are off,
+// so an event landing between the check and the WAIT is never missed; the
+// ISR then runs as soon as interrupts are back on. OSCCON.SLPEN is left at
+// its reset value of 0, so WAIT enters Idle and the timers and UART keep
+// running.
+
+void wait_init(void){
+	// Only an interrupt with non-zero priority can end WAIT, and in IDLE the
+	// UART3 RX interrupt is the only one enabled. Its reset priority is 0, so
+	// without this wait_for_command() would never return. It never vectors:
+	// the enable bit is only set while interrupts are off.
+	IPC7bits.U3IP = 1;
+	IEC1CLR = _IEC1_U3RXIE_MASK;
+	IFS1CLR = _IFS1_U3RXIF_MASK;
+}
+
+void wait_for_command(void){
+	while (1){
+		__builtin_disable_interrupts();
+		if (U3STAbits.URXDA){
+			__builtin_enable_interrupts();
+			return;
+		}
+		IEC1SET = _IEC1_U3RXIE_MASK;	// a received byte ends the WAIT...
+		__asm__ __volatile__ ("wait");
+		IEC1CLR = _IEC1_U3RXIE_MASK;	// ...but never vectors; there is no UART ISR
+		IFS1CLR = _IFS1_U3RXIF_MASK;
+		__builtin_enable_interrupts();
+	}
+}
+
+void wait_while_mode(Mode_datatype m){
+	while (1){
+		__builtin_disable_interrupts();
+		if (mode != m){
+			__builtin_enable_interrupts();
+			return;
+		}
+		__asm__ __volatile__ ("wait");	// the next control loop tick ends the WAIT
+		__builtin_enable_interrupts();
+	}
+}
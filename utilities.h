@@ -1,9 +1,16 @@
 #ifndef UTILITIES__H__
 #define UTILITIES__H__
 
-typedef enum {IDLE=0, PWM=1, ITEST=2, HOLD=3, TRACK=4} Mode_datatype;
+// Compiler memory barrier: buffers shared with an ISR are not volatile, so
+// loads and stores may not be moved across the point where ownership changes.
+#define MEMORY_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+typedef enum {IDLE=0, PWM=1, ITEST=2, HOLD=3, TRACK=4, IFRESP=5, PFRESP=6} Mode_datatype;
 
 void set_mode(Mode_datatype m);
 Mode_datatype get_mode(void);
+void wait_init(void);					// let UART3 RX wake the CPU from WAIT
+void wait_for_command(void);			// sleep until a byte arrives on UART3
+void wait_while_mode(Mode_datatype m);	// sleep until an ISR changes the mode from m
 
 #endif // UTILITIES__H__
\ No newline at end of file